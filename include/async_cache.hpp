@@ -0,0 +1,268 @@
+// Coroutine friendly asynchronous facade over the fixed sized cache (requires C++20)
+#ifndef ASYNC_CACHE_HPP
+#define ASYNC_CACHE_HPP
+
+// keep in sync with COROUTINE_PROBE_SOURCE in CMakeLists.txt, __cplusplus is not checked as MSVC
+// keeps it at 199711L without /Zc:__cplusplus
+#if !defined(__cpp_impl_coroutine)
+#error "async_cache.hpp requires a C++20 compiler with coroutine support"
+#endif
+
+#include "cache.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace caches
+{
+
+    /*
+     * Asynchronous wrapper around fixed_sized_cache for code running on a C++20 coroutine executor
+     * A hit completes immediately without suspending the awaiting coroutine, while a miss suspends it
+     * until the loader's awaitable resolves. Concurrent misses on the same key are coalesced, so the
+     * loader is invoked only once and every waiter gets resumed with the loaded value (or exception).
+     * Waiters are resumed on whichever thread completes the loader's awaitable.
+     * The cache must outlive every load it has started.
+     * Key - Type of a key [the key should be a hash-able one]
+     * Value - Type of a value stored in the cache
+     * Policy - Type of a policy to be used with the cache
+     * HashMap - Type of the hashmap to use for caching
+     */
+    template <typename Key, typename Value, template <typename> class Policy = NoCachePolicy,
+              typename HashMap = std::unordered_map<Key, Value>>
+    class async_fixed_sized_cache
+    {
+    public:
+        using cache_type = fixed_sized_cache<Key, Value, Policy, HashMap>;
+        using on_erase_cb = typename cache_type::on_erase_cb;
+
+    private:
+        // state shared between a running load and the coroutines waiting for it
+        struct pending_load
+        {
+            std::optional<Value> value;
+            std::exception_ptr error;
+            std::vector<std::coroutine_handle<>> waiters;
+            // set once the key gets written or removed while the load is in flight
+            bool superseded = false;
+        };
+
+    public:
+        /*
+         * Awaitable returned by GetAsync(...)
+         * Loader - Callable taking `const Key&` and returning an awaitable that produces a Value
+         */
+        template <typename Loader> class lookup
+        {
+        public:
+            lookup(async_fixed_sized_cache& owner, const Key& key, Loader loader)
+                    : owner{owner}, key{key}, loader{std::move(loader)}
+            {
+            }
+
+            bool await_ready() { return owner.cache.TryGet(key, value); }
+
+            bool await_suspend(std::coroutine_handle<> awaiting)
+            {
+                std::shared_ptr<pending_load> load;
+                bool start_load = false;
+                {
+                    std::lock_guard<std::mutex> lock{owner.pending_guard};
+
+                    // a load might have been completed between await_ready and now
+                    if (owner.cache.TryGet(key, value))
+                    {
+                        return false;
+                    }
+
+                    auto& slot = owner.pending_loads[key];
+
+                    if (!slot)
+                    {
+                        slot = std::make_shared<pending_load>();
+                        start_load = true;
+                    }
+
+                    slot->waiters.push_back(awaiting);
+                    load = pending = slot;
+                }
+
+                // the awaiting coroutine may already be resumed by the time Load returns,
+                // so no member of this awaiter is touched afterwards
+                if (start_load)
+                {
+                    owner.Load(key, std::move(loader), std::move(load));
+                }
+
+                return true;
+            }
+
+            Value await_resume()
+            {
+                if (!pending)
+                {
+                    return std::move(value);
+                }
+
+                if (pending->error)
+                {
+                    std::rethrow_exception(pending->error);
+                }
+
+                return *pending->value;
+            }
+
+        private:
+            async_fixed_sized_cache& owner;
+            Key key;
+            Loader loader;
+            Value value{};
+            std::shared_ptr<pending_load> pending;
+        };
+
+        /*
+         * Asynchronous fixed sized cache constructor
+         * throws std::invalid_argument if max_cache_size == 0
+         * max_size - Maximum size of the cache
+         * policy - Cache policy to use
+         * on_erase on_erase_cb - Callback function called when cache's element get erased
+         */
+        explicit async_fixed_sized_cache(
+            size_t max_size, const Policy<Key> policy = Policy<Key>{},
+            on_erase_cb on_erase = [](const Key&, const Value&) {})
+                : cache{max_size, policy, on_erase}
+        {
+        }
+
+        async_fixed_sized_cache(const async_fixed_sized_cache&) = delete;
+        async_fixed_sized_cache& operator=(const async_fixed_sized_cache&) = delete;
+
+        /*
+         * Gets the element from the cache, loading it on a miss
+         * key - Element's key that we are trying to get
+         * loader - Called as `loader(key)` on a miss, must return an awaitable producing the Value
+         * Returns an awaitable resuming with a copy of the value. If the loader throws, the exception
+         * is rethrown to every coalesced waiter and nothing is put into the cache.
+         * If the key is written or removed by Put(...) or Remove(...) while the load is in flight, the load
+         * is superseded: the waiters which already joined it still get the loaded value, but it is not put
+         * into the cache, and later misses start a fresh load.
+         */
+        template <typename Loader> lookup<Loader> GetAsync(const Key& key, Loader loader)
+        {
+            return lookup<Loader>{*this, key, std::move(loader)};
+        }
+
+        /*
+         * Puts element into the cache
+         * key - The Key to which value has to be assigned
+         * value - The Value to assign to the given key
+         */
+        void Put(const Key& key, const Value& value) noexcept
+        {
+            std::lock_guard<std::mutex> lock{pending_guard};
+
+            Supersede(key);
+            cache.Put(key, value);
+        }
+
+        /*
+         * Checks if the given key is presented in the cache
+         * key - Element's key that is to be checked
+         */
+        bool Cached(const Key& key) const noexcept { return cache.Cached(key); }
+
+        /*
+         * Returns the number of elements currently present in the cache
+         */
+        std::size_t Size() const { return cache.Size(); }
+
+        /*
+         * Removes an element specified by key
+         * key - Key of the element that is to be removed
+         * Returns true if the element specified by the key was found and successfully deleted
+         */
+        bool Remove(const Key& key)
+        {
+            std::lock_guard<std::mutex> lock{pending_guard};
+
+            Supersede(key);
+            return cache.Remove(key);
+        }
+
+    private:
+        // detaches an in-flight load of the key so its stale result does not end up in the cache
+        void Supersede(const Key& key) noexcept
+        {
+            auto element = pending_loads.find(key);
+
+            if (element != pending_loads.end())
+            {
+                element->second->superseded = true;
+                pending_loads.erase(element);
+            }
+        }
+
+        // fire and forget coroutine type used to drive the loaders
+        struct detached_load
+        {
+            struct promise_type
+            {
+                detached_load get_return_object() noexcept { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() noexcept {}
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+        };
+
+        // the loader is kept alive in this frame until its awaitable resolves
+        template <typename Loader> detached_load Load(Key key, Loader loader, std::shared_ptr<pending_load> load)
+        {
+            try
+            {
+                load->value.emplace(co_await loader(key));
+            }
+            catch (...)
+            {
+                load->error = std::current_exception();
+            }
+
+            std::vector<std::coroutine_handle<>> waiters;
+            {
+                std::lock_guard<std::mutex> lock{pending_guard};
+
+                // checked under pending_guard, so a concurrent Put(...) or Remove(...) is either seen here
+                // or applied after the loaded value, a superseded load is already detached from pending_loads
+                if (!load->superseded)
+                {
+                    if (load->value)
+                    {
+                        cache.Put(key, *load->value);
+                    }
+
+                    pending_loads.erase(key);
+                }
+
+                waiters.swap(load->waiters);
+            }
+
+            for (auto waiter : waiters)
+            {
+                waiter.resume();
+            }
+        }
+
+    private:
+        cache_type cache;
+        std::mutex pending_guard;
+        std::unordered_map<Key, std::shared_ptr<pending_load>> pending_loads;
+    };
+} // namespace caches
+
+#endif // ASYNC_CACHE_HPP
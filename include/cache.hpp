@@ -97,6 +97,28 @@ namespace caches
             return GetInternal(key);
         }
 
+        /*
+         * Tries to copy an element by the given key out of the cache
+         * key - Tries to get the element by key
+         * value - Receives a copy of the element if it is presented in the cache
+         * Returns true if the element was found and copied into value
+         * Returns false if the element is not presented in the cache and value is left untouched
+         * Unlike the iterator returning overload, the copy is taken while the cache is still locked,
+         * so the result stays valid even if the element gets evicted by a concurrent operation.
+         */
+        bool TryGet(const Key& key, Value& value) const
+        {
+            operation_guard lock{safe_operation};
+            auto element = GetInternal(key);
+
+            if (element.second)
+            {
+                value = element.first->second;
+            }
+
+            return element.second;
+        }
+
         /*
          * Gets the element from the cache if the element is present
          * key - Element's key that we are trying to get
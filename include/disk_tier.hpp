@@ -0,0 +1,535 @@
+// Log structured, memory mapped on-disk cache tier (POSIX only)
+#ifndef DISK_TIER_HPP
+#define DISK_TIER_HPP
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace caches
+{
+
+    /*
+     * Describes how keys and values are laid out on disk
+     * A codec has to provide the following static functions:
+     * Size(value) - Returns the number of bytes the encoded value takes
+     * Encode(value, out) - Writes Size(value) bytes describing the value to out
+     * Decode(data, size) - Builds a value back from size bytes, data points straight into the mapped segment
+     * Specialise it for key and value types which are neither trivially copyable nor std::string
+     */
+    template <typename T, typename Enable = void> struct disk_codec;
+
+    // trivially copyable values are stored as is and decoded with a single copy out of the mapping
+    template <typename T> struct disk_codec<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+    {
+        static std::size_t Size(const T&) noexcept { return sizeof(T); }
+
+        static void Encode(const T& value, char* out) noexcept { std::memcpy(out, &value, sizeof(T)); }
+
+        static T Decode(const char* data, std::size_t) noexcept
+        {
+            T value;
+            std::memcpy(&value, data, sizeof(T));
+            return value;
+        }
+    };
+
+    template <> struct disk_codec<std::string>
+    {
+        static std::size_t Size(const std::string& value) noexcept { return value.size(); }
+
+        static void Encode(const std::string& value, char* out) noexcept { value.copy(out, value.size()); }
+
+        static std::string Decode(const char* data, std::size_t size) { return std::string(data, size); }
+    };
+
+    /*
+     * Append-only, log structured storage for values spilled out of memory
+     * Records (a small header, the key and the value) are appended to fixed sized segment files and located
+     * through a compact in-memory index (segment id, offset and sizes per key). Reads go through a read-only
+     * shared mapping of the segment, so a value is decoded straight from the page cache without an
+     * intermediate buffer. Overwritten and removed values leave dead bytes behind, which a background thread
+     * reclaims by copying the live values of mostly dead segments into the active one and dropping the old
+     * segment. The compactor finds those live values by walking the records of the segment itself, so it
+     * never scans the whole index.
+     * Segment files are unlinked right after creation, so the tier is scratch space that never outlives
+     * the process and never leaves garbage behind, even after a crash.
+     * Key - Type of a key [the key should be a hash-able one]
+     * Value - Type of a value stored in the tier
+     * Codec - Type describing the on-disk layout of a value, see disk_codec
+     * KeyCodec - Type describing the on-disk layout of a key, see disk_codec
+     */
+    template <typename Key, typename Value, typename Codec = disk_codec<Value>, typename KeyCodec = disk_codec<Key>>
+    class disk_tier
+    {
+    public:
+        using operation_guard = typename std::lock_guard<std::mutex>;
+
+        static constexpr std::size_t default_segment_size = 64 * 1024 * 1024;
+
+        /*
+         * Disk tier constructor
+         * throws std::invalid_argument if segment_size is 0 or above 4 GiB
+         * throws std::invalid_argument if compaction_threshold is not in (0, 1]
+         * throws std::system_error if the first segment could not be created
+         * directory - Directory the segment files are created in
+         * segment_size - Size of a single segment file, larger records get a segment of their own
+         * compaction_threshold - Fraction of live bytes below which a full segment gets compacted
+         */
+        explicit disk_tier(const std::string& directory, std::size_t segment_size = default_segment_size,
+                           double compaction_threshold = 0.5)
+                : segment_directory{directory}, max_segment_size{segment_size},
+                  live_ratio_threshold{compaction_threshold}
+        {
+            if (max_segment_size == 0)
+            {
+                throw std::invalid_argument{"Size of a segment should be non-zero"};
+            }
+
+            if (max_segment_size > std::numeric_limits<std::uint32_t>::max())
+            {
+                throw std::invalid_argument{"Size of a segment should not exceed 4 GiB"};
+            }
+
+            if (!(live_ratio_threshold > 0.0 && live_ratio_threshold <= 1.0))
+            {
+                throw std::invalid_argument{"Compaction threshold should be in the (0, 1] range"};
+            }
+
+            active_segment_id = CreateSegment(max_segment_size);
+            compactor = std::thread{&disk_tier::Compact, this};
+        }
+
+        disk_tier(const disk_tier&) = delete;
+        disk_tier& operator=(const disk_tier&) = delete;
+
+        ~disk_tier() noexcept
+        {
+            {
+                operation_guard lock{safe_operation};
+                stopping = true;
+            }
+
+            compaction_needed.notify_one();
+            compactor.join();
+        }
+
+        /*
+         * Appends element to the tier, replacing a previously stored value
+         * throws std::system_error if the value could not be written
+         * throws std::length_error if the encoded record exceeds 4 GiB
+         * key - The Key to which value has to be assigned
+         * value - The Value to assign to the given key
+         */
+        void Put(const Key& key, const Value& value)
+        {
+            const std::size_t key_size = KeyCodec::Size(key);
+            const std::size_t value_size = Codec::Size(value);
+            const std::size_t record_size = sizeof(record_header) + key_size + value_size;
+
+            // each size is bounded by the key and value size of the platform, so the sum cannot wrap around
+            if (record_size > std::numeric_limits<std::uint32_t>::max())
+            {
+                throw std::length_error{"Record is too large for the disk tier"};
+            }
+
+            const record_header header{static_cast<std::uint32_t>(key_size), static_cast<std::uint32_t>(value_size)};
+            std::vector<char> buffer(record_size);
+
+            std::memcpy(buffer.data(), &header, sizeof(record_header));
+            KeyCodec::Encode(key, buffer.data() + sizeof(record_header));
+            Codec::Encode(value, buffer.data() + sizeof(record_header) + key_size);
+
+            operation_guard lock{safe_operation};
+            const location stored = Append(buffer.data(), header);
+            auto element_iterator = index.find(key);
+
+            if (element_iterator == index.end())
+            {
+                index.emplace(key, stored);
+            }
+            else
+            {
+                MarkDead(element_iterator->second);
+                element_iterator->second = stored;
+            }
+        }
+
+        /*
+         * Tries to read an element by the given key from the tier
+         * key - Tries to get the element by key
+         * value - Receives the element if it is presented in the tier
+         * Returns true if the element was found, false otherwise
+         */
+        bool TryGet(const Key& key, Value& value) const
+        {
+            std::shared_ptr<segment> holder;
+            location element;
+            {
+                operation_guard lock{safe_operation};
+                auto element_iterator = index.find(key);
+
+                if (element_iterator == index.end())
+                {
+                    return false;
+                }
+
+                element = element_iterator->second;
+                holder = segments.at(element.segment_id);
+            }
+
+            // the segment stays mapped while we hold it, even if it gets compacted meanwhile
+            value = Codec::Decode(ValueData(*holder, element), element.value_size);
+
+            return true;
+        }
+
+        /*
+         * Reads an element by the given key and removes it from the tier
+         * key - Key of the element that is to be taken out
+         * value - Receives the element if it is presented in the tier
+         * Returns true if the element was found and removed, false otherwise
+         */
+        bool Take(const Key& key, Value& value)
+        {
+            std::shared_ptr<segment> holder;
+            location element;
+            {
+                operation_guard lock{safe_operation};
+                auto element_iterator = index.find(key);
+
+                if (element_iterator == index.end())
+                {
+                    return false;
+                }
+
+                element = element_iterator->second;
+                holder = segments.at(element.segment_id);
+                index.erase(element_iterator);
+                MarkDead(element);
+            }
+
+            value = Codec::Decode(ValueData(*holder, element), element.value_size);
+
+            return true;
+        }
+
+        /*
+         * Checks if the given key is presented in the tier
+         * key - Element's key that is to be checked
+         */
+        bool Cached(const Key& key) const noexcept
+        {
+            operation_guard lock{safe_operation};
+            return index.find(key) != index.cend();
+        }
+
+        /*
+         * Returns the number of elements currently present in the tier
+         */
+        std::size_t Size() const
+        {
+            operation_guard lock{safe_operation};
+
+            return index.size();
+        }
+
+        /*
+         * Removes an element specified by key
+         * key - Key of the element that is to be removed
+         * Returns true if the element was found and removed, false otherwise
+         */
+        bool Remove(const Key& key)
+        {
+            operation_guard lock{safe_operation};
+            auto element_iterator = index.find(key);
+
+            if (element_iterator == index.end())
+            {
+                return false;
+            }
+
+            MarkDead(element_iterator->second);
+            index.erase(element_iterator);
+
+            return true;
+        }
+
+    private:
+        // index entry, 16 bytes per key
+        struct location
+        {
+            std::uint32_t segment_id;
+            std::uint32_t offset;
+            std::uint32_t size;
+            std::uint32_t value_size;
+        };
+
+        // prefix of every record, followed by the encoded key and the encoded value
+        struct record_header
+        {
+            std::uint32_t key_size;
+            std::uint32_t value_size;
+        };
+
+        // an unlinked, sparse segment file together with its read-only mapping
+        // only the active segment keeps its file descriptor open, the mapping stays valid without it
+        struct segment
+        {
+            segment(int fd, char* data, std::size_t capacity) : fd{fd}, data{data}, capacity{capacity} {}
+
+            segment(const segment&) = delete;
+            segment& operator=(const segment&) = delete;
+
+            ~segment() noexcept
+            {
+                munmap(data, capacity);
+                Seal();
+            }
+
+            // no more writes are going to happen, closes the descriptor so sealed segments do not use up fds
+            void Seal() noexcept
+            {
+                if (fd != -1)
+                {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+
+            int fd;
+            char* data;
+            std::size_t capacity;
+            std::size_t used = 0;
+            std::size_t live = 0;
+        };
+
+        static std::size_t RecordSize(const record_header& header) noexcept
+        {
+            return sizeof(record_header) + header.key_size + header.value_size;
+        }
+
+        static const char* ValueData(const segment& holder, const location& element) noexcept
+        {
+            return holder.data + element.offset + element.size - element.value_size;
+        }
+
+        static std::system_error SystemError(const char* what)
+        {
+            return std::system_error{errno, std::generic_category(), what};
+        }
+
+        std::uint32_t CreateSegment(std::size_t capacity)
+        {
+            std::string path = segment_directory + "/memecache-segment-XXXXXX";
+            int fd = mkstemp(&path[0]);
+
+            if (fd == -1)
+            {
+                throw SystemError("Unable to create a disk tier segment");
+            }
+
+            unlink(path.c_str());
+
+            if (ftruncate(fd, static_cast<off_t>(capacity)) == -1)
+            {
+                auto error = SystemError("Unable to size a disk tier segment");
+                close(fd);
+                throw error;
+            }
+
+            void* data = mmap(nullptr, capacity, PROT_READ, MAP_SHARED, fd, 0);
+
+            if (data == MAP_FAILED)
+            {
+                auto error = SystemError("Unable to map a disk tier segment");
+                close(fd);
+                throw error;
+            }
+
+            const std::uint32_t segment_id = next_segment_id++;
+            segments.emplace(segment_id, std::make_shared<segment>(fd, static_cast<char*>(data), capacity));
+
+            return segment_id;
+        }
+
+        // appends raw bytes to the active segment, rolling over to a new one once it is full
+        location Append(const char* bytes, const record_header& header)
+        {
+            const std::size_t size = RecordSize(header);
+            auto active = segments.at(active_segment_id);
+
+            if (active->used + size > active->capacity)
+            {
+                const std::uint32_t sealed_segment_id = active_segment_id;
+
+                active_segment_id = CreateSegment(size > max_segment_size ? size : max_segment_size);
+                active->Seal();
+                active = segments.at(active_segment_id);
+                Sealed(sealed_segment_id);
+            }
+
+            std::size_t written = 0;
+
+            while (written < size)
+            {
+                auto result = pwrite(active->fd, bytes + written, size - written,
+                                     static_cast<off_t>(active->used + written));
+
+                if (result == -1 && errno != EINTR)
+                {
+                    throw SystemError("Unable to write to a disk tier segment");
+                }
+
+                if (result > 0)
+                {
+                    written += static_cast<std::size_t>(result);
+                }
+            }
+
+            location stored{active_segment_id, static_cast<std::uint32_t>(active->used), static_cast<std::uint32_t>(size),
+                            header.value_size};
+            active->used += size;
+            active->live += size;
+
+            return stored;
+        }
+
+        void MarkDead(const location& element)
+        {
+            segments.at(element.segment_id)->live -= element.size;
+
+            if (element.segment_id != active_segment_id)
+            {
+                Sealed(element.segment_id);
+            }
+        }
+
+        // drops a sealed segment without live values or wakes the compactor up if it is worth compacting
+        void Sealed(std::uint32_t segment_id)
+        {
+            auto element = segments.find(segment_id);
+
+            if (element == segments.end())
+            {
+                return;
+            }
+
+            if (element->second->live == 0)
+            {
+                segments.erase(element);
+            }
+            else if (NeedsCompaction(*element->second))
+            {
+                compaction_needed.notify_one();
+            }
+        }
+
+        bool NeedsCompaction(const segment& candidate) const noexcept
+        {
+            return candidate.live < candidate.used * live_ratio_threshold;
+        }
+
+        // background thread moving live values out of mostly dead segments
+        void Compact()
+        {
+            std::unique_lock<std::mutex> lock{safe_operation};
+
+            while (!stopping)
+            {
+                auto candidate = segments.begin();
+
+                while (candidate != segments.end() &&
+                       (candidate->first == active_segment_id || !NeedsCompaction(*candidate->second)))
+                {
+                    ++candidate;
+                }
+
+                if (candidate == segments.end())
+                {
+                    compaction_needed.wait(lock);
+                    continue;
+                }
+
+                const std::uint32_t victim_id = candidate->first;
+                const std::shared_ptr<segment> victim = candidate->second;
+
+                try
+                {
+                    // a sealed segment never changes, so its records are walked and decoded without the lock
+                    for (std::size_t offset = 0; offset < victim->used && victim->live > 0;)
+                    {
+                        lock.unlock();
+
+                        record_header header;
+                        std::memcpy(&header, victim->data + offset, sizeof(record_header));
+                        const Key key = KeyCodec::Decode(victim->data + offset + sizeof(record_header), header.key_size);
+
+                        lock.lock();
+
+                        if (stopping)
+                        {
+                            return;
+                        }
+
+                        // the record is live only if the index still points at it
+                        auto element_iterator = index.find(key);
+
+                        if (element_iterator != index.end() && element_iterator->second.segment_id == victim_id &&
+                            element_iterator->second.offset == offset)
+                        {
+                            element_iterator->second = Append(victim->data + offset, header);
+                            victim->live -= RecordSize(header);
+                        }
+
+                        offset += RecordSize(header);
+                    }
+
+                    segments.erase(victim_id);
+                }
+                catch (const std::exception&)
+                {
+                    if (!lock.owns_lock())
+                    {
+                        lock.lock();
+                    }
+
+                    // the victim stays readable as is, compaction is retried on the next notification
+                    compaction_needed.wait(lock);
+                }
+            }
+        }
+
+    private:
+        std::unordered_map<Key, location> index;
+        std::map<std::uint32_t, std::shared_ptr<segment>> segments;
+        std::uint32_t active_segment_id = 0;
+        std::uint32_t next_segment_id = 0;
+        std::string segment_directory;
+        std::size_t max_segment_size;
+        double live_ratio_threshold;
+        mutable std::mutex safe_operation;
+        std::condition_variable compaction_needed;
+        bool stopping = false;
+        std::thread compactor;
+    };
+} // namespace caches
+
+#endif // DISK_TIER_HPP
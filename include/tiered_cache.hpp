@@ -0,0 +1,291 @@
+// Two tiered cache spilling evicted elements to a memory mapped on-disk tier
+#ifndef TIERED_CACHE_HPP
+#define TIERED_CACHE_HPP
+
+#include "cache.hpp"
+#include "disk_tier.hpp"
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace caches
+{
+
+    /*
+     * Fixed sized in-memory cache backed by a log structured on-disk tier
+     * Elements evicted from memory by the eviction policy are spilled to the disk tier instead of being
+     * dropped. A miss in memory checks the disk tier before reporting absence, and a hit there promotes
+     * the element back to memory (which may in turn spill another one). An element lives in at most one
+     * of the tiers at a time. If an evicted element cannot be written to disk, it is simply dropped.
+     * Memory hits take no lock besides the in-memory cache's own. Operations that have to look at the
+     * disk tier serialise per key through a set of striped locks, and evicted elements are written to
+     * disk only after the in-memory cache's lock has been released.
+     * Key - Type of a key [the key should be a hash-able one]
+     * Value - Type of a value stored in the cache
+     * Policy - Type of a policy to be used with the in-memory tier
+     * Codec - Type describing the on-disk layout of a value, see disk_codec
+     * KeyCodec - Type describing the on-disk layout of a key, see disk_codec
+     */
+    template <typename Key, typename Value, template <typename> class Policy = NoCachePolicy,
+              typename Codec = disk_codec<Value>, typename KeyCodec = disk_codec<Key>>
+    class tiered_cache
+    {
+    public:
+        using operation_guard = typename std::lock_guard<std::mutex>;
+
+        static constexpr std::size_t key_guard_count = 64;
+
+        /*
+         * Tiered cache constructor
+         * throws std::invalid_argument if max_memory_size == 0 or segment_size == 0
+         * throws std::system_error if the disk tier could not be created
+         * max_memory_size - Maximum number of elements kept in memory
+         * directory - Directory the disk tier's segment files are created in
+         * policy - Cache policy to use for the in-memory tier
+         * segment_size - Size of a single disk tier segment file
+         */
+        tiered_cache(size_t max_memory_size, const std::string& directory, const Policy<Key> policy = Policy<Key>{},
+                     std::size_t segment_size = disk_tier<Key, Value, Codec, KeyCodec>::default_segment_size)
+                : disk{directory, segment_size},
+                  memory{max_memory_size, policy, [this](const Key& key, const Value& value) { Evicted(key, value); }}
+        {
+        }
+
+        tiered_cache(const tiered_cache&) = delete;
+        tiered_cache& operator=(const tiered_cache&) = delete;
+
+        /*
+         * Puts element into the in-memory tier, dropping a stale copy from the disk tier
+         * key - The Key to which value has to be assigned
+         * value - The Value to assign to the given key
+         */
+        void Put(const Key& key, const Value& value)
+        {
+            {
+                operation_guard lock{KeyGuard(key)};
+
+                DropSpilled(key);
+                memory.Put(key, value);
+            }
+
+            SpillEvicted();
+        }
+
+        /*
+         * Tries to get an element by the given key, promoting it to memory if it was found on disk
+         * key - Tries to get the element by key
+         * value - Receives a copy of the element if it is presented in either tier
+         * Returns true if the element was found, false otherwise
+         */
+        bool TryGet(const Key& key, Value& value)
+        {
+            if (memory.TryGet(key, value))
+            {
+                return true;
+            }
+
+            {
+                operation_guard lock{KeyGuard(key)};
+
+                // the element might have been promoted while we were waiting for the key guard
+                if (memory.TryGet(key, value))
+                {
+                    return true;
+                }
+
+                if (!TakeEvicted(key, value) && !disk.Take(key, value))
+                {
+                    return false;
+                }
+
+                memory.Put(key, value);
+            }
+
+            SpillEvicted();
+
+            return true;
+        }
+
+        /*
+         * Gets the element from the cache if the element is present in either tier
+         * key - Element's key that we are trying to get
+         * Returns a copy of the value, as promotions and spills may move the stored one around
+         */
+        Value Get(const Key& key)
+        {
+            Value value;
+
+            if (!TryGet(key, value))
+            {
+                throw std::range_error{"No such element in the cache"};
+            }
+
+            return value;
+        }
+
+        /*
+         * Checks if the given key is presented in either tier without promoting it
+         * key - Element's key that is to be checked
+         */
+        bool Cached(const Key& key) const noexcept
+        {
+            if (memory.Cached(key))
+            {
+                return true;
+            }
+
+            operation_guard lock{KeyGuard(key)};
+
+            return memory.Cached(key) || EvictedCached(key) || disk.Cached(key);
+        }
+
+        /*
+         * Returns the number of elements currently present in both tiers
+         */
+        std::size_t Size() const { return memory.Size() + EvictedSize() + disk.Size(); }
+
+        /*
+         * Returns the number of elements currently spilled to the disk tier
+         */
+        std::size_t DiskSize() const { return disk.Size(); }
+
+        /*
+         * Removes an element specified by key from both tiers
+         * key - Key of the element that is to be removed
+         * Returns true if the element was found and successfully deleted
+         */
+        bool Remove(const Key& key)
+        {
+            operation_guard lock{KeyGuard(key)};
+
+            // the on_erase callback queues the removed element for spilling, so it is dropped from there too
+            const bool removed_from_memory = memory.Remove(key);
+
+            return DropSpilled(key) || removed_from_memory;
+        }
+
+    private:
+        std::mutex& KeyGuard(const Key& key) const { return key_guards[std::hash<Key>{}(key) % key_guard_count]; }
+
+        // on_erase callback of the in-memory tier, runs under its lock so it only queues the element
+        void Evicted(const Key& key, const Value& value) noexcept
+        {
+            operation_guard lock{evicted_guard};
+
+            try
+            {
+                evicted[key] = value;
+            }
+            catch (const std::exception&)
+            {
+                // the evicted element is dropped, just like a plain fixed_sized_cache would do
+            }
+        }
+
+        bool TakeEvicted(const Key& key, Value& value)
+        {
+            operation_guard lock{evicted_guard};
+            auto element = evicted.find(key);
+
+            if (element == evicted.end())
+            {
+                return false;
+            }
+
+            value = std::move(element->second);
+            evicted.erase(element);
+
+            return true;
+        }
+
+        bool EvictedCached(const Key& key) const
+        {
+            operation_guard lock{evicted_guard};
+
+            return evicted.find(key) != evicted.cend();
+        }
+
+        std::size_t EvictedSize() const
+        {
+            operation_guard lock{evicted_guard};
+
+            return evicted.size();
+        }
+
+        // removes the element from the spill queue and the disk tier, the key guard has to be held
+        bool DropSpilled(const Key& key)
+        {
+            bool dropped = false;
+            {
+                operation_guard lock{evicted_guard};
+
+                dropped = evicted.erase(key) != 0;
+            }
+
+            return disk.Remove(key) || dropped;
+        }
+
+        // writes queued evicted elements to the disk tier, must be called without holding any key guard
+        void SpillEvicted()
+        {
+            std::vector<Key> keys;
+
+            for (;;)
+            {
+                keys.clear();
+                {
+                    operation_guard lock{evicted_guard};
+
+                    for (const auto& element : evicted)
+                    {
+                        keys.push_back(element.first);
+                    }
+                }
+
+                if (keys.empty())
+                {
+                    return;
+                }
+
+                for (const auto& key : keys)
+                {
+                    operation_guard key_lock{KeyGuard(key)};
+                    Value value;
+
+                    // another thread may have spilled, promoted or removed the element meanwhile,
+                    // and a stale copy must not be spilled if the key got back into memory
+                    if (!TakeEvicted(key, value) || memory.Cached(key))
+                    {
+                        continue;
+                    }
+
+                    try
+                    {
+                        disk.Put(key, value);
+                    }
+                    catch (const std::exception&)
+                    {
+                        // the evicted element is dropped, just like a plain fixed_sized_cache would do
+                    }
+                }
+            }
+        }
+
+    private:
+        disk_tier<Key, Value, Codec, KeyCodec> disk;
+        fixed_sized_cache<Key, Value, Policy> memory;
+        // elements evicted from memory which are not written to the disk tier yet
+        std::unordered_map<Key, Value> evicted;
+        mutable std::mutex evicted_guard;
+        mutable std::array<std::mutex, key_guard_count> key_guards;
+    };
+} // namespace caches
+
+#endif // TIERED_CACHE_HPP
@@ -0,0 +1,110 @@
+#include "include/async_cache.hpp"
+#include "include/lru_cache_policy.hpp"
+#include <coroutine>
+#include <deque>
+#include <iostream>
+#include <string>
+
+// alias for easy class typing
+template <typename Key, typename Value>
+using async_lru_cache_t = caches::async_fixed_sized_cache<Key, Value, caches::LRUCachePolicy>;
+
+// coroutines ready to be resumed by the toy executor below
+std::deque<std::coroutine_handle<>> ready_queue;
+
+// number of times the backend has been hit
+int backend_loads = 0;
+
+void printLine() { std::cout << "==============================================================================\n"; }
+
+// awaitable simulating a slow backend, it completes the next time the executor runs
+struct backend_fetch
+{
+    std::string key;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { ready_queue.push_back(handle); }
+    int await_resume()
+    {
+        ++backend_loads;
+        return static_cast<int>(key.size()) * 100;
+    }
+};
+
+// fire and forget coroutine type for the demo requests
+struct request
+{
+    struct promise_type
+    {
+        request get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+request serve(async_lru_cache_t<std::string, int>& cache, std::string key)
+{
+    int value = co_await cache.GetAsync(key, [](const std::string& key) { return backend_fetch{key}; });
+
+    std::cout << "Value for key '" << key << "': " << value << '\n';
+}
+
+void run_executor()
+{
+    while (!ready_queue.empty())
+    {
+        auto handle = ready_queue.front();
+        ready_queue.pop_front();
+        handle.resume();
+    }
+}
+
+int main()
+{
+    std::cout << "Hello Enterpret!\n";
+
+    constexpr std::size_t CACHE_SIZE = 256;
+    async_lru_cache_t<std::string, int> lru_cache(CACHE_SIZE);
+
+    printLine();
+    std::cout << "Using async LRU cache, three concurrent misses on 'Hello' and one on 'world!'\n";
+
+    // all of these suspend, the misses on the same key share a single load
+    serve(lru_cache, "Hello");
+    serve(lru_cache, "Hello");
+    serve(lru_cache, "Hello");
+    serve(lru_cache, "world!");
+    run_executor();
+
+    std::cout << "Backend loads: " << backend_loads << '\n';
+
+    printLine();
+    std::cout << "Cache hits complete without suspending\n";
+
+    serve(lru_cache, "Hello");
+    std::cout << "Backend loads: " << backend_loads << '\n';
+
+    printLine();
+
+    return 0;
+}
+
+/*
+Output
+
+Hello Enterpret!
+==============================================================================
+Using async LRU cache, three concurrent misses on 'Hello' and one on 'world!'
+Value for key 'Hello': 500
+Value for key 'Hello': 500
+Value for key 'Hello': 500
+Value for key 'world!': 600
+Backend loads: 2
+==============================================================================
+Cache hits complete without suspending
+Value for key 'Hello': 500
+Backend loads: 2
+==============================================================================
+*/
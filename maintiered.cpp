@@ -0,0 +1,60 @@
+#include "include/lru_cache_policy.hpp"
+#include "include/tiered_cache.hpp"
+#include <iostream>
+#include <string>
+
+// alias for easy class typing
+template <typename Key, typename Value>
+using tiered_lru_cache_t = caches::tiered_cache<Key, Value, caches::LRUCachePolicy>;
+
+void printLine() { std::cout << "==============================================================================\n"; }
+
+int main()
+{
+    std::cout << "Hello Enterpret!\n";
+
+    // keeps only two elements in memory, the rest gets spilled to segment files in the current directory
+    constexpr std::size_t CACHE_SIZE = 2;
+    tiered_lru_cache_t<std::string, std::string> tiered_cache(CACHE_SIZE, ".");
+
+    tiered_cache.Put("M", "Memory");
+    tiered_cache.Put("E", "Evicted");
+    tiered_cache.Put("D", "Disk");
+    tiered_cache.Put("S", "Spilled");
+
+    printLine();
+
+    std::cout << "Using tiered LRU cache\n"
+              << "Elements cached: " << tiered_cache.Size() << '\n'
+              << "Elements spilled to disk: " << tiered_cache.DiskSize() << '\n';
+
+    printLine();
+
+    // 'M' was spilled to disk, reading it promotes it back to memory and spills 'D' instead
+    std::cout << "Value for key '"
+              << "M"
+              << "': " << tiered_cache.Get("M") << '\n';
+    std::cout << "Value for key '"
+              << "E"
+              << "': " << tiered_cache.Get("E") << '\n';
+    std::cout << "Elements spilled to disk: " << tiered_cache.DiskSize() << '\n';
+
+    printLine();
+
+    return 0;
+}
+
+/*
+Output
+
+Hello Enterpret!
+==============================================================================
+Using tiered LRU cache
+Elements cached: 4
+Elements spilled to disk: 2
+==============================================================================
+Value for key 'M': Memory
+Value for key 'E': Evicted
+Elements spilled to disk: 2
+==============================================================================
+*/